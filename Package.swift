@@ -57,6 +57,10 @@ let package = Package(
                 "PhoenixChannelsClient",
                 "GliaOpenTelemetry"
             ]
+        ),
+        .testTarget(
+            name: "GliaSDKTests",
+            dependencies: ["GliaSDK"]
         )
     ]
 )
@@ -0,0 +1,164 @@
+import Foundation
+import GliaCoreSDK
+import ImageIO
+import UniformTypeIdentifiers
+
+/// Opt-in downscaling and recompression of image attachments before upload.
+///
+/// Images larger than `maxPixelSize` are downscaled and re-encoded in their own format. The format is changed
+/// only when the site does not accept it, or for HEIC/HEIF sources when `convertsHEIF` is set; images with
+/// transparency are then converted to PNG rather than JPEG. Animated images, anything that is not an image, and re-encoded copies
+/// that would not get smaller than an acceptable original are uploaded as is.
+public struct AttachmentImagePreprocessing {
+    /// Longest side of the uploaded image in pixels.
+    public var maxPixelSize: CGFloat
+    /// Lossy compression quality in the 0...1 range.
+    public var compressionQuality: CGFloat
+    /// Directory for re-encoded copies. Defaults to the temporary directory.
+    public var outputDirectory: URL
+    /// Converts HEIC/HEIF images even when the site accepts them, because operators on browsers other than
+    /// Safari cannot display them. The converted copy is uploaded even if it is larger than the original.
+    public var convertsHEIF: Bool
+
+    public init(
+        maxPixelSize: CGFloat = 2048,
+        compressionQuality: CGFloat = 0.7,
+        outputDirectory: URL = FileManager.default.temporaryDirectory,
+        convertsHEIF: Bool = false
+    ) {
+        self.maxPixelSize = maxPixelSize
+        self.compressionQuality = compressionQuality
+        self.outputDirectory = outputDirectory
+        self.convertsHEIF = convertsHEIF
+    }
+
+    /// Returns a file pointing to a downscaled copy of `file`, or `file` itself when preprocessing does not apply.
+    /// - Parameter allowedContentTypes: `Site.allowedFileContentTypes`; the output type is picked from this list.
+    public func process(_ file: EngagementFile, allowedContentTypes: [String]) -> EngagementFile {
+        guard
+            let url = file.url,
+            let source = ImageDownsampling.source(url: url),
+            CGImageSourceGetCount(source) == 1,
+            let sourceIdentifier = CGImageSourceGetType(source) as String?,
+            let sourceType = UTType(sourceIdentifier),
+            sourceType.conforms(to: .image)
+        else { return file }
+
+        let properties = CGImageSourceCopyPropertiesAtIndex(source, 0, nil) as? [CFString: Any]
+        let width = properties?[kCGImagePropertyPixelWidth] as? CGFloat ?? 0
+        let height = properties?[kCGImagePropertyPixelHeight] as? CGFloat ?? 0
+        let hasAlpha = properties?[kCGImagePropertyHasAlpha] as? Bool ?? false
+        let longestSide = max(width, height)
+        // The original is still uploaded when re-encoding does not help, unless the site cannot take it
+        // or the integrator asked for HEIF to be converted.
+        let mustConvert = !isAllowed(sourceType, in: allowedContentTypes)
+            || (convertsHEIF && sourceType.conforms(to: .heif))
+        guard
+            longestSide > 0,
+            longestSide > maxPixelSize || mustConvert,
+            let targetType = outputType(
+                for: sourceType,
+                mustConvert: mustConvert,
+                hasAlpha: hasAlpha,
+                allowedContentTypes: allowedContentTypes
+            ),
+            longestSide > maxPixelSize || targetType != sourceType
+        else { return file }
+
+        guard
+            let image = ImageDownsampling.thumbnail(from: source, maxPixelSize: min(longestSide, maxPixelSize)),
+            let outputURL = write(image, as: targetType, name: url.deletingPathExtension().lastPathComponent)
+        else { return file }
+
+        let originalSize = (try? url.resourceValues(forKeys: [.fileSizeKey]).fileSize) ?? Int.max
+        let outputSize = (try? outputURL.resourceValues(forKeys: [.fileSizeKey]).fileSize) ?? Int.max
+        guard outputSize < originalSize || (mustConvert && targetType != sourceType) else {
+            try? FileManager.default.removeItem(at: outputURL)
+            return file
+        }
+        return EngagementFile(name: renamedFileName(file.name, for: targetType), url: outputURL)
+    }
+}
+
+private extension AttachmentImagePreprocessing {
+    /// Keeps the source format unless a conversion is required. Converted images go to JPEG,
+    /// or to PNG when they have transparency or JPEG is not accepted.
+    func outputType(
+        for sourceType: UTType,
+        mustConvert: Bool,
+        hasAlpha: Bool,
+        allowedContentTypes: [String]
+    ) -> UTType? {
+        let writableTypes = (CGImageDestinationCopyTypeIdentifiers() as? [String]) ?? []
+        let isWritable: (UTType) -> Bool = { writableTypes.contains($0.identifier) }
+        let keepsSource = isAllowed(sourceType, in: allowedContentTypes) && isWritable(sourceType)
+        guard mustConvert else { return keepsSource ? sourceType : nil }
+        let candidates: [UTType] = hasAlpha ? [.png] : [.jpeg, .png]
+        if let type = candidates.first(where: { isAllowed($0, in: allowedContentTypes) && isWritable($0) }) {
+            return type
+        }
+        return keepsSource ? sourceType : nil
+    }
+
+    /// Replaces the extension of `name` so the uploaded name matches the re-encoded bytes.
+    /// Names without an extension are kept.
+    func renamedFileName(_ name: String, for type: UTType) -> String {
+        let name = name as NSString
+        guard
+            !name.pathExtension.isEmpty,
+            let fileExtension = type.preferredFilenameExtension,
+            let renamed = (name.deletingPathExtension as NSString).appendingPathExtension(fileExtension)
+        else { return name as String }
+        return renamed
+    }
+
+    func isAllowed(_ type: UTType, in allowedContentTypes: [String]) -> Bool {
+        guard let mimeType = type.preferredMIMEType else { return false }
+        return allowedContentTypes.contains { allowed in
+            allowed == mimeType || allowed == "image/*" || allowed == "*/*"
+        }
+    }
+
+    func write(_ image: CGImage, as type: UTType, name: String) -> URL? {
+        let fileName = "\(name)-\(UUID().uuidString).\(type.preferredFilenameExtension ?? "img")"
+        let outputURL = outputDirectory.appendingPathComponent(fileName)
+        guard let destination = CGImageDestinationCreateWithURL(outputURL as CFURL, type.identifier as CFString, 1, nil) else {
+            return nil
+        }
+        let options = [kCGImageDestinationLossyCompressionQuality: compressionQuality] as CFDictionary
+        CGImageDestinationAddImage(destination, image, options)
+        guard CGImageDestinationFinalize(destination) else {
+            try? FileManager.default.removeItem(at: outputURL)
+            return nil
+        }
+        return outputURL
+    }
+}
+
+extension GliaCore {
+    /// Same as `uploadFileToEngagement(_:progress:completion:)`, but runs image attachments through
+    /// `preprocessing` first, using the site's allowed content types. Preprocessing happens off the main thread.
+    public func uploadFileToEngagement(
+        _ file: EngagementFile,
+        preprocessing: AttachmentImagePreprocessing,
+        siteConfiguration: SiteConfigurationCache = .shared,
+        progress: EngagementFileProgressBlock?,
+        completion: @escaping EngagementFileCompletionBlock
+    ) {
+        siteConfiguration.fetchSiteConfiguration { [weak self] result in
+            guard case let .success(site) = result else {
+                self?.uploadFileToEngagement(file, progress: progress, completion: completion)
+                return
+            }
+            DispatchQueue.global(qos: .userInitiated).async {
+                let processed = preprocessing.process(file, allowedContentTypes: site.allowedFileContentTypes)
+                self?.uploadFileToEngagement(processed, progress: progress) { information, error in
+                    if processed !== file, let url = processed.url {
+                        try? FileManager.default.removeItem(at: url)
+                    }
+                    completion(information, error)
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,297 @@
+import CryptoKit
+import Foundation
+import GliaCoreSDK
+
+/// Size-bounded disk cache for engagement file contents.
+///
+/// Entries are keyed by `EngagementFile.id`, while bytes are stored once per SHA-256 content hash,
+/// so the same attachment shared in several messages occupies the disk only once.
+/// Least recently used entries are evicted when the total size exceeds `byteLimit`.
+/// Disk work happens on a private serial queue; writes are asynchronous but ordered before later reads.
+public final class EngagementFileCache {
+    public static let shared = EngagementFileCache()
+
+    public let byteLimit: Int
+
+    private let directory: URL
+    private let fileManager: FileManager
+    private let queue = DispatchQueue(label: "com.glia.sdk.engagement-file-cache")
+    // Accessed on `queue` only.
+    private var index: [String: Entry]
+    private var isIndexPersistScheduled = false
+
+    /// - Parameters:
+    ///   - directory: Location of the cache. Defaults to a subdirectory of the user's caches directory.
+    ///   - byteLimit: Maximum total size of cached contents, 100 MB by default.
+    public init(
+        directory: URL? = nil,
+        byteLimit: Int = 100 * 1024 * 1024,
+        fileManager: FileManager = .default
+    ) {
+        let caches = fileManager.urls(for: .cachesDirectory, in: .userDomainMask)[0]
+        let directory = directory ?? caches.appendingPathComponent("GliaEngagementFiles", isDirectory: true)
+        try? fileManager.createDirectory(at: directory, withIntermediateDirectories: true)
+        let indexData = try? Data(contentsOf: directory.appendingPathComponent(EngagementFileCache.indexFileName))
+        self.directory = directory
+        self.byteLimit = byteLimit
+        self.fileManager = fileManager
+        self.index = indexData.flatMap { try? JSONDecoder().decode([String: Entry].self, from: $0) } ?? [:]
+    }
+
+    /// Returns cached contents for the file id and marks the entry as recently used.
+    /// Blocks the calling thread while reading from disk; prefer `data(forFileId:completion:)` on the main thread.
+    public func data(forFileId fileId: String) -> Data? {
+        queue.sync { lookup(fileId) }
+    }
+
+    /// Looks the file id up on the cache queue and calls `completion` on `completionQueue`.
+    public func data(
+        forFileId fileId: String,
+        completionQueue: DispatchQueue = .main,
+        completion: @escaping (Data?) -> Void
+    ) {
+        queue.async { [weak self] in
+            let data = self?.lookup(fileId)
+            completionQueue.async { completion(data) }
+        }
+    }
+
+    public func store(_ data: Data, forFileId fileId: String) {
+        queue.async { [weak self] in
+            guard let self = self else { return }
+            let hash = SHA256.hash(data: data).map { String(format: "%02x", $0) }.joined()
+            let url = self.blobURL(hash)
+            if !self.fileManager.fileExists(atPath: url.path) {
+                guard (try? data.write(to: url, options: .atomic)) != nil else { return }
+            }
+            let previous = self.index[fileId]
+            self.index[fileId] = Entry(hash: hash, size: data.count, lastAccess: Date())
+            if let previous = previous, previous.hash != hash {
+                self.removeBlobIfUnreferenced(previous.hash)
+            }
+            self.evictIfNeeded()
+            self.persistIndex()
+        }
+    }
+
+    public func removeData(forFileId fileId: String) {
+        queue.async { [weak self] in
+            guard let self = self, let entry = self.index.removeValue(forKey: fileId) else { return }
+            self.removeBlobIfUnreferenced(entry.hash)
+            self.persistIndex()
+        }
+    }
+
+    public func removeAll() {
+        queue.async { [weak self] in
+            guard let self = self else { return }
+            self.index = [:]
+            try? self.fileManager.removeItem(at: self.directory)
+            try? self.fileManager.createDirectory(at: self.directory, withIntermediateDirectories: true)
+        }
+    }
+
+    /// Total size of the distinct cached contents in bytes.
+    public var totalSize: Int {
+        queue.sync { currentSize() }
+    }
+}
+
+private extension EngagementFileCache {
+    static let indexFileName = "index.json"
+    /// Delay used to batch index writes caused by reads.
+    static let indexPersistDelay: DispatchTimeInterval = .seconds(2)
+
+    struct Entry: Codable {
+        let hash: String
+        let size: Int
+        var lastAccess: Date
+    }
+
+    func blobURL(_ hash: String) -> URL {
+        directory.appendingPathComponent(hash)
+    }
+
+    func currentSize() -> Int {
+        var sizes: [String: Int] = [:]
+        index.values.forEach { sizes[$0.hash] = $0.size }
+        return sizes.values.reduce(0, +)
+    }
+
+    func removeBlobIfUnreferenced(_ hash: String) {
+        guard !index.values.contains(where: { $0.hash == hash }) else { return }
+        try? fileManager.removeItem(at: blobURL(hash))
+    }
+
+    func evictIfNeeded() {
+        var size = currentSize()
+        guard size > byteLimit else { return }
+        let candidates = index.sorted { $0.value.lastAccess < $1.value.lastAccess }
+        for (fileId, entry) in candidates where size > byteLimit {
+            index[fileId] = nil
+            if !index.values.contains(where: { $0.hash == entry.hash }) {
+                try? fileManager.removeItem(at: blobURL(entry.hash))
+                size -= entry.size
+            }
+        }
+    }
+
+    func lookup(_ fileId: String) -> Data? {
+        guard var entry = index[fileId] else { return nil }
+        guard let data = try? Data(contentsOf: blobURL(entry.hash), options: .mappedIfSafe) else {
+            index[fileId] = nil
+            persistIndex()
+            return nil
+        }
+        entry.lastAccess = Date()
+        index[fileId] = entry
+        schedulePersistIndex()
+        return data
+    }
+
+    /// Access times only affect eviction order, so losing the latest ones is harmless
+    /// and the index is not rewritten on every hit.
+    func schedulePersistIndex() {
+        guard !isIndexPersistScheduled else { return }
+        isIndexPersistScheduled = true
+        queue.asyncAfter(deadline: .now() + Self.indexPersistDelay) { [weak self] in
+            guard let self = self, self.isIndexPersistScheduled else { return }
+            self.persistIndex()
+        }
+    }
+
+    func persistIndex() {
+        isIndexPersistScheduled = false
+        guard let data = try? JSONEncoder().encode(index) else { return }
+        try? data.write(to: directory.appendingPathComponent(Self.indexFileName), options: .atomic)
+    }
+}
+
+extension GliaCore {
+    /// Same as `fetchFile(engagementFile:progress:completion:)`, but answers from `cache` when the file
+    /// was downloaded before. Deleted files are evicted from the cache and fail with `FileError.fileUnavailable`
+    /// without a network request. `completion` is always called asynchronously on the main queue.
+    public func fetchFile(
+        engagementFile: EngagementFile,
+        cache: EngagementFileCache,
+        progress: EngagementFileProgressBlock?,
+        completion: @escaping (Result<Data, GliaCoreError>) -> Void
+    ) {
+        let completeOnMain: (Result<Data, GliaCoreError>) -> Void = { result in
+            DispatchQueue.main.async { completion(result) }
+        }
+        guard let fileId = engagementFile.id else {
+            fetchFile(engagementFile: engagementFile, progress: progress) { fileData, error in
+                completeOnMain(Self.result(fileData, error))
+            }
+            return
+        }
+        if engagementFile.isDeleted == true {
+            cache.removeData(forFileId: fileId)
+            completeOnMain(.failure(Self.deletedFileError))
+            return
+        }
+        cache.data(forFileId: fileId) { data in
+            if let data = data {
+                completeOnMain(.success(data))
+                return
+            }
+            self.fetchFile(engagementFile: engagementFile, progress: progress) { fileData, error in
+                if let data = fileData?.data {
+                    cache.store(data, forFileId: fileId)
+                }
+                completeOnMain(Self.result(fileData, error))
+            }
+        }
+    }
+
+    private static func result(_ fileData: EngagementFileData?, _ error: GliaCoreError?) -> Result<Data, GliaCoreError> {
+        if let data = fileData?.data {
+            return .success(data)
+        }
+        return .failure(error ?? GliaCoreError(reason: "File data is missing", error: GeneralError.internalError))
+    }
+
+    fileprivate static var deletedFileError: GliaCoreError {
+        GliaCoreError(reason: "File has been deleted", error: FileError.fileUnavailable)
+    }
+}
+
+extension GliaCore.SecureConversations {
+    /// Same as `downloadFile(_:progress:completion:)`, but answers from `cache` when the file
+    /// was downloaded before. Deleted files are evicted from the cache and fail with `FileError.fileUnavailable`
+    /// without a network request. `completion` is always called asynchronously on the main queue.
+    /// Cancelling the returned value before the cache lookup finishes prevents the download from starting.
+    @discardableResult
+    public func downloadFile(
+        _ file: EngagementFile,
+        cache: EngagementFileCache,
+        progress: EngagementFileProgressBlock?,
+        completion: @escaping (Result<Data, Error>) -> Void
+    ) -> GliaCore.Cancellable {
+        let completeOnMain: (Result<Data, Error>) -> Void = { result in
+            DispatchQueue.main.async { completion(result) }
+        }
+        guard let fileId = file.id else {
+            return downloadFile(file, progress: progress) { result in
+                completeOnMain(result.map(\.data))
+            }
+        }
+        if file.isDeleted == true {
+            cache.removeData(forFileId: fileId)
+            completeOnMain(.failure(GliaCore.deletedFileError))
+            return GliaCore.Cancellable(isCancelled: true)
+        }
+        let pending = PendingDownload()
+        cache.data(forFileId: fileId) { data in
+            if let data = data {
+                completeOnMain(.success(data))
+                return
+            }
+            guard !pending.isCancelled else { return }
+            pending.download = self.downloadFile(file, progress: progress) { result in
+                if case let .success(fileData) = result {
+                    cache.store(fileData.data, forFileId: fileId)
+                }
+                completeOnMain(result.map(\.data))
+            }
+        }
+        return GliaCore.Cancellable { pending.cancel() }
+    }
+}
+
+/// Cancellation state of a download that starts only after an asynchronous cache miss.
+private final class PendingDownload {
+    private let lock = NSLock()
+    private var _isCancelled = false
+    private var _download: GliaCore.Cancellable?
+
+    var isCancelled: Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        return _isCancelled
+    }
+
+    var download: GliaCore.Cancellable? {
+        get {
+            lock.lock()
+            defer { lock.unlock() }
+            return _download
+        }
+        set {
+            lock.lock()
+            let cancelled = _isCancelled
+            _download = newValue
+            lock.unlock()
+            if cancelled { newValue?.cancel() }
+        }
+    }
+
+    func cancel() {
+        lock.lock()
+        _isCancelled = true
+        let download = _download
+        lock.unlock()
+        download?.cancel()
+    }
+}
@@ -0,0 +1,206 @@
+import Foundation
+import GliaCoreSDK
+
+/// Uploads batches of files with a shared concurrency limit and yields an `Attachment` per batch.
+///
+/// Batches are started in priority order; within the same priority files are uploaded first-in, first-out.
+/// Progress is aggregated per batch and weighted by file size. Callbacks are delivered on the main queue.
+public final class EngagementFilesUploader {
+    public typealias Upload = (
+        EngagementFile,
+        EngagementFileProgressBlock?,
+        @escaping (Result<EngagementFileInformation, Error>) -> Void
+    ) -> GliaCore.Cancellable?
+
+    public enum Priority: Int, Comparable {
+        case low
+        case normal
+        case high
+
+        public static func < (lhs: Priority, rhs: Priority) -> Bool {
+            lhs.rawValue < rhs.rawValue
+        }
+    }
+
+    public let maxConcurrentUploads: Int
+
+    private let performUpload: Upload
+    private let queue = DispatchQueue(label: "com.glia.sdk.files-uploader")
+    // Accessed on `queue` only.
+    private var pending: [Job] = []
+    private var running: [UUID: GliaCore.Cancellable] = [:]
+
+    public init(maxConcurrentUploads: Int = 3, upload: @escaping Upload) {
+        self.maxConcurrentUploads = max(1, maxConcurrentUploads)
+        self.performUpload = upload
+    }
+
+    /// Uploader for ongoing engagements, backed by `GliaCore.uploadFileToEngagement(_:progress:completion:)`.
+    public static func engagement(
+        core: GliaCore = .sharedInstance,
+        maxConcurrentUploads: Int = 3
+    ) -> EngagementFilesUploader {
+        EngagementFilesUploader(maxConcurrentUploads: maxConcurrentUploads) { file, progress, completion in
+            core.uploadFileToEngagement(file, progress: progress) { information, error in
+                if let information = information {
+                    completion(.success(information))
+                } else {
+                    completion(.failure(error ?? GliaCoreError(reason: "Upload failed", error: GeneralError.internalError)))
+                }
+            }
+            return nil
+        }
+    }
+
+    /// Uploader for secure conversations, backed by `SecureConversations.uploadFile(_:progress:completion:)`.
+    public static func secureConversations(
+        core: GliaCore = .sharedInstance,
+        maxConcurrentUploads: Int = 3
+    ) -> EngagementFilesUploader {
+        EngagementFilesUploader(maxConcurrentUploads: maxConcurrentUploads) { file, progress, completion in
+            core.secureConversations.uploadFile(file, progress: progress, completion: completion)
+        }
+    }
+
+    /// Schedules `files` for upload.
+    /// - Parameters:
+    ///   - progress: Aggregate fraction completed for the whole batch.
+    ///   - completion: Attachment referencing all uploaded files in the original order, or the first error.
+    ///     Remaining files of a failed or cancelled batch are not uploaded.
+    @discardableResult
+    public func upload(
+        _ files: [EngagementFile],
+        priority: Priority = .normal,
+        progress: ((Double) -> Void)? = nil,
+        completion: @escaping (Result<Attachment, Error>) -> Void
+    ) -> GliaCore.Cancellable {
+        let batch = Batch(files: files, progress: progress, completion: completion)
+        queue.async { [weak self] in
+            guard let self = self else { return }
+            guard !files.isEmpty else {
+                batch.finish(.success(Attachment(files: [])))
+                return
+            }
+            let jobs = files.indices.map { Job(batch: batch, index: $0, priority: priority) }
+            // Stable insertion keeps FIFO order among jobs with equal priority.
+            let position = self.pending.firstIndex { $0.priority < priority } ?? self.pending.endIndex
+            self.pending.insert(contentsOf: jobs, at: position)
+            self.startPending()
+        }
+        return GliaCore.Cancellable { [weak self] in
+            self?.queue.async { self?.cancel(batch) }
+        }
+    }
+}
+
+private extension EngagementFilesUploader {
+    struct Job {
+        let id = UUID()
+        let batch: Batch
+        let index: Int
+        let priority: Priority
+    }
+
+    /// Per-batch state; mutated on the uploader queue only.
+    final class Batch {
+        let files: [EngagementFile]
+        let weights: [Double]
+        let progress: ((Double) -> Void)?
+        let completion: (Result<Attachment, Error>) -> Void
+        var fractions: [Double]
+        var results: [EngagementFileInformation?]
+        var jobIds: Set<UUID> = []
+        var isFinished = false
+
+        init(files: [EngagementFile], progress: ((Double) -> Void)?, completion: @escaping (Result<Attachment, Error>) -> Void) {
+            self.files = files
+            self.weights = files.map { file in
+                let size = file.url.flatMap { try? $0.resourceValues(forKeys: [.fileSizeKey]).fileSize } ?? 0
+                return Double(max(size, 1))
+            }
+            self.progress = progress
+            self.completion = completion
+            self.fractions = Array(repeating: 0, count: files.count)
+            self.results = Array(repeating: nil, count: files.count)
+        }
+
+        func update(fraction: Double, at index: Int) {
+            fractions[index] = fraction
+            let total = weights.reduce(0, +)
+            let completed = zip(weights, fractions).reduce(0) { $0 + $1.0 * $1.1 }
+            let value = total > 0 ? completed / total : 0
+            DispatchQueue.main.async { [progress] in progress?(value) }
+        }
+
+        func finish(_ result: Result<Attachment, Error>) {
+            guard !isFinished else { return }
+            isFinished = true
+            DispatchQueue.main.async { [completion] in completion(result) }
+        }
+    }
+
+    func startPending() {
+        while running.count < maxConcurrentUploads, !pending.isEmpty {
+            let job = pending.removeFirst()
+            guard !job.batch.isFinished else { continue }
+            start(job)
+        }
+    }
+
+    func start(_ job: Job) {
+        let batch = job.batch
+        batch.jobIds.insert(job.id)
+        running[job.id] = GliaCore.Cancellable()
+        let cancellable = performUpload(
+            batch.files[job.index],
+            { [weak self] fileProgress in
+                self?.queue.async {
+                    guard !batch.isFinished else { return }
+                    batch.update(fraction: fileProgress.fractionCompleted, at: job.index)
+                }
+            },
+            { [weak self] result in
+                self?.queue.async { self?.complete(job, with: result) }
+            }
+        )
+        if let cancellable = cancellable {
+            running[job.id] = cancellable
+        }
+    }
+
+    func complete(_ job: Job, with result: Result<EngagementFileInformation, Error>) {
+        running[job.id] = nil
+        let batch = job.batch
+        batch.jobIds.remove(job.id)
+        defer { startPending() }
+        guard !batch.isFinished else { return }
+
+        switch result {
+        case let .success(information):
+            batch.results[job.index] = information
+            batch.update(fraction: 1, at: job.index)
+            let informations = batch.results.compactMap { $0 }
+            guard informations.count == batch.files.count else { return }
+            batch.finish(.success(Attachment(files: informations.map { EngagementFile(id: $0.id) })))
+        case let .failure(error):
+            cancelRunning(of: batch)
+            batch.finish(.failure(error))
+        }
+    }
+
+    func cancel(_ batch: Batch) {
+        guard !batch.isFinished else { return }
+        cancelRunning(of: batch)
+        batch.finish(.failure(GliaCoreError(reason: "Upload cancelled")))
+        startPending()
+    }
+
+    /// Slots stay occupied until each upload reports completion, since some uploads cannot be cancelled
+    /// and keep running; `complete(_:with:)` frees them.
+    func cancelRunning(of batch: Batch) {
+        pending.removeAll { $0.batch === batch }
+        for id in batch.jobIds {
+            running[id]?.cancel()
+        }
+    }
+}
@@ -1,4 +1,7 @@
 /// Swift Package Manager requires a folder with our package's target name to exist inside the Sources folder,
-/// and a file has to be inside. As our framework is closed source, then we need to use a dummy file to comply
-/// with this requirement.
+/// and a file has to be inside. As our framework is closed source, this file only satisfies that requirement.
+///
+/// The other files in this target add helpers on top of `GliaCoreSDK` (caching, uploads, message diffing and
+/// similar). They are compiled into the `GliaSDK` Swift package product only. The `GliaCoreSDK` pod vends
+/// the prebuilt xcframework alone, so these helpers are not available to CocoaPods integrators.
 struct GliaSDK { }
@@ -0,0 +1,25 @@
+import Foundation
+import ImageIO
+
+/// ImageIO based downsampling that never decodes the full-size bitmap.
+enum ImageDownsampling {
+    /// Returns a decoded image whose longest side does not exceed `maxPixelSize`,
+    /// with EXIF orientation already applied.
+    static func thumbnail(from source: CGImageSource, maxPixelSize: CGFloat) -> CGImage? {
+        let options = [
+            kCGImageSourceCreateThumbnailFromImageAlways: true,
+            kCGImageSourceCreateThumbnailWithTransform: true,
+            kCGImageSourceShouldCacheImmediately: true,
+            kCGImageSourceThumbnailMaxPixelSize: max(1, Int(maxPixelSize.rounded(.up)))
+        ] as CFDictionary
+        return CGImageSourceCreateThumbnailAtIndex(source, 0, options)
+    }
+
+    static func source(data: Data) -> CGImageSource? {
+        CGImageSourceCreateWithData(data as CFData, [kCGImageSourceShouldCache: false] as CFDictionary)
+    }
+
+    static func source(url: URL) -> CGImageSource? {
+        CGImageSourceCreateWithURL(url as CFURL, [kCGImageSourceShouldCache: false] as CFDictionary)
+    }
+}
@@ -0,0 +1,361 @@
+import CryptoKit
+import Foundation
+import GliaCoreSDK
+import Network
+import UIKit
+
+/// Durable, ordered outbox for outgoing messages.
+///
+/// Messages are sent one at a time in the order they were enqueued. When sending fails because of
+/// the network, the message stays at the head of the outbox and is retried with the same
+/// `SendMessagePayload.messageId`: immediately once the network path becomes satisfied again, or with
+/// capped exponential backoff and jitter while the path looks satisfied but the backend is unreachable. Enqueuing a payload
+/// whose `messageId` is already in the outbox is ignored.
+///
+/// Pending messages are written to disk with complete file protection and restored on the next launch.
+/// Each outbox is stored per `Scope`, so messages queued by one visitor are never restored for another
+/// site, environment or visitor. Create a new outbox after the authenticated visitor changes, and use
+/// `GliaCore.Authentication.deauthenticate(shouldStopPushNotifications:discarding:_:)` to log out.
+///
+/// `SendMessagePayload` can only be created with a fresh `messageId`, so restored messages are sent under
+/// a new id and the server cannot deduplicate them against an earlier attempt. Messages that had been
+/// handed to `send` before the app was terminated may already be delivered; they are therefore not resent
+/// automatically but restored into `unconfirmedPayloads`, where the integrator decides whether to
+/// `resendUnconfirmed()` (risking a duplicate) or `discardUnconfirmed()`.
+public final class MessageOutbox {
+    public typealias Send = (SendMessagePayload, @escaping (Result<Message, Error>) -> Void) -> Void
+
+    /// Identity the persisted messages belong to.
+    public struct Scope: Hashable {
+        public let siteId: String
+        public let environment: String
+        public let visitorId: String
+
+        public init(siteId: String, environment: String, visitorId: String) {
+            self.siteId = siteId
+            self.environment = environment
+            self.visitorId = visitorId
+        }
+    }
+
+    /// Called on the main queue when a message is delivered or fails with a non-network error.
+    public var onDelivery: ((SendMessagePayload, Result<Message, Error>) -> Void)?
+
+    private let send: Send
+    private let storageURL: URL
+    private let fileManager: FileManager
+    private let pathMonitor = NWPathMonitor()
+    private let queue = DispatchQueue(label: "com.glia.sdk.message-outbox")
+    private var protectedDataObserver: NSObjectProtocol?
+    // Accessed on `queue` only.
+    private var pending: [SendMessagePayload] = []
+    /// Restored messages whose delivery state is unknown.
+    private var unconfirmed: [SendMessagePayload] = []
+    /// Messages handed to `send` at least once, persisted so they are not resent blindly after relaunch.
+    private var attemptedIds: Set<SendMessagePayload.MessageId> = []
+    private var isSending = false
+    private var isNetworkAvailable = true
+    private var retryAttempt = 0
+    private var retryWork: DispatchWorkItem?
+    /// False while the persisted file exists but cannot be read yet, e.g. before first unlock.
+    private var isRestored = false
+
+    /// - Parameters:
+    ///   - name: Distinguishes persisted outboxes of the same scope, for example per conversation type.
+    ///   - scope: Site, environment and visitor the queued messages belong to.
+    ///   - send: Performs the actual request.
+    public init(name: String, scope: Scope, send: @escaping Send, fileManager: FileManager = .default) {
+        let directory = MessageOutbox.storageDirectory(fileManager: fileManager)
+            .appendingPathComponent(MessageOutbox.directoryName(for: scope), isDirectory: true)
+        try? fileManager.createDirectory(
+            at: directory,
+            withIntermediateDirectories: true,
+            attributes: [.protectionKey: FileProtectionType.complete]
+        )
+        self.storageURL = directory.appendingPathComponent("\(name).json")
+        self.fileManager = fileManager
+        self.send = send
+
+        protectedDataObserver = NotificationCenter.default.addObserver(
+            forName: UIApplication.protectedDataDidBecomeAvailableNotification,
+            object: nil,
+            queue: nil
+        ) { [weak self] _ in
+            self?.queue.async { self?.flush() }
+        }
+        pathMonitor.pathUpdateHandler = { [weak self] path in
+            self?.queue.async {
+                guard let self = self else { return }
+                let wasAvailable = self.isNetworkAvailable
+                self.isNetworkAvailable = path.status == .satisfied
+                if self.isNetworkAvailable, !wasAvailable {
+                    // Connectivity came back, so the backoff built up while offline no longer applies.
+                    self.cancelRetry()
+                    self.retryAttempt = 0
+                }
+                self.flush()
+            }
+        }
+        pathMonitor.start(queue: queue)
+        queue.async { [weak self] in self?.flush() }
+    }
+
+    deinit {
+        pathMonitor.cancel()
+        retryWork?.cancel()
+        if let observer = protectedDataObserver {
+            NotificationCenter.default.removeObserver(observer)
+        }
+    }
+
+    /// Outbox for ongoing engagements, backed by `GliaCore.send(messagePayload:completion:)`.
+    /// - Parameter visitorId: `GliaCore.VisitorInfo.id` of the current visitor.
+    public static func engagement(visitorId: String, core: GliaCore = .sharedInstance) -> MessageOutbox {
+        MessageOutbox(name: "engagement", scope: core.outboxScope(visitorId: visitorId)) { payload, completion in
+            core.send(messagePayload: payload) { result in
+                completion(result.mapError { $0 as Error })
+            }
+        }
+    }
+
+    /// Outbox for secure conversations, backed by `SecureConversations.send(secureMessagePayload:queueIds:completion:)`.
+    /// - Parameter visitorId: `GliaCore.VisitorInfo.id` of the authenticated visitor.
+    public static func secureConversations(
+        queueIds: [String],
+        visitorId: String,
+        core: GliaCore = .sharedInstance
+    ) -> MessageOutbox {
+        MessageOutbox(
+            name: "secure-conversations",
+            scope: core.outboxScope(visitorId: visitorId)
+        ) { payload, completion in
+            _ = core.secureConversations.send(secureMessagePayload: payload, queueIds: queueIds, completion: completion)
+        }
+    }
+
+    public func enqueue(_ payload: SendMessagePayload) {
+        queue.async { [weak self] in
+            guard let self = self else { return }
+            guard !self.pending.contains(where: { $0.messageId == payload.messageId }) else { return }
+            self.pending.append(payload)
+            self.persist()
+            self.flush()
+        }
+    }
+
+    /// Payloads that are not delivered yet, in sending order.
+    public var pendingPayloads: [SendMessagePayload] {
+        queue.sync { pending }
+    }
+
+    /// Restored payloads that were already being sent when the app was terminated. They are kept
+    /// until `resendUnconfirmed()` or `discardUnconfirmed()` is called.
+    public var unconfirmedPayloads: [SendMessagePayload] {
+        queue.sync {
+            restoreIfNeeded()
+            return unconfirmed
+        }
+    }
+
+    /// Moves unconfirmed payloads to the front of the outbox. Known duplicate risk: a message the server
+    /// already received before termination is delivered again, since it is resent under a new `messageId`.
+    public func resendUnconfirmed() {
+        queue.async { [weak self] in
+            guard let self = self else { return }
+            self.restoreIfNeeded()
+            self.pending = self.unconfirmed + self.pending
+            self.unconfirmed = []
+            self.persist()
+            self.flush()
+        }
+    }
+
+    public func discardUnconfirmed() {
+        queue.async { [weak self] in
+            guard let self = self else { return }
+            self.restoreIfNeeded()
+            self.unconfirmed = []
+            self.persist()
+        }
+    }
+
+    /// Drops all queued messages and deletes the persisted file. Returns once the file is gone.
+    public func removeAll() {
+        queue.sync {
+            pending = []
+            unconfirmed = []
+            attemptedIds = []
+            cancelRetry()
+            retryAttempt = 0
+            isRestored = true
+            persist()
+        }
+    }
+
+    /// Deletes the persisted messages of every scope. Outboxes that are still alive keep their
+    /// in-memory queue; call `removeAll()` on them first.
+    public static func removeAllPersisted(fileManager: FileManager = .default) {
+        try? fileManager.removeItem(at: storageDirectory(fileManager: fileManager))
+    }
+}
+
+extension GliaCore.Authentication {
+    /// Same as `deauthenticate(shouldStopPushNotifications:_:)`, but first discards the messages queued in
+    /// `outboxes` and every persisted outbox, so they are neither sent on behalf of the next visitor
+    /// nor left on disk after logout.
+    public func deauthenticate(
+        shouldStopPushNotifications: Bool = false,
+        discarding outboxes: [MessageOutbox],
+        _ completion: @escaping (Result<Void, GliaCoreError>) -> Void
+    ) {
+        outboxes.forEach { $0.removeAll() }
+        MessageOutbox.removeAllPersisted()
+        deauthenticate(shouldStopPushNotifications: shouldStopPushNotifications, completion)
+    }
+}
+
+private extension GliaCore {
+    func outboxScope(visitorId: String) -> MessageOutbox.Scope {
+        MessageOutbox.Scope(siteId: site, environment: environment, visitorId: visitorId)
+    }
+}
+
+private extension MessageOutbox {
+    static func storageDirectory(fileManager: FileManager) -> URL {
+        let support = fileManager.urls(for: .applicationSupportDirectory, in: .userDomainMask)[0]
+        return support.appendingPathComponent("GliaMessageOutbox", isDirectory: true)
+    }
+
+    /// Hashed so that visitor identifiers do not appear in file names.
+    static func directoryName(for scope: Scope) -> String {
+        let key = [scope.environment, scope.siteId, scope.visitorId].joined(separator: "\n")
+        return SHA256.hash(data: Data(key.utf8)).map { String(format: "%02x", $0) }.joined()
+    }
+
+    /// Loads persisted messages ahead of anything enqueued meanwhile. While protected data is unavailable
+    /// the file stays untouched and loading is retried on the next flush.
+    func restoreIfNeeded() {
+        guard !isRestored else { return }
+        guard fileManager.fileExists(atPath: storageURL.path) else {
+            isRestored = true
+            return
+        }
+        guard let data = try? Data(contentsOf: storageURL) else { return }
+        let records = (try? JSONDecoder().decode([Record].self, from: data)) ?? []
+        unconfirmed = records.filter { $0.wasAttempted }.map(\.payload)
+        pending = records.filter { !$0.wasAttempted }.map(\.payload) + pending
+        isRestored = true
+        persist()
+    }
+
+    func flush() {
+        restoreIfNeeded()
+        guard isRestored, !isSending, retryWork == nil, isNetworkAvailable, let payload = pending.first else { return }
+        isSending = true
+        if attemptedIds.insert(payload.messageId).inserted {
+            persist()
+        }
+        send(payload) { [weak self] result in
+            self?.queue.async { self?.complete(payload, with: result) }
+        }
+    }
+
+    func complete(_ payload: SendMessagePayload, with result: Result<Message, Error>) {
+        isSending = false
+        if case let .failure(error) = result, Self.isNetworkError(error) {
+            // Keep the message and retry once the path reports connectivity again.
+            isNetworkAvailable = pathMonitor.currentPath.status == .satisfied && isNetworkAvailable
+            if isNetworkAvailable {
+                scheduleRetry()
+            }
+            return
+        }
+        retryAttempt = 0
+        pending.removeAll { $0.messageId == payload.messageId }
+        attemptedIds.remove(payload.messageId)
+        persist()
+        DispatchQueue.main.async { [weak self] in self?.onDelivery?(payload, result) }
+        flush()
+    }
+
+    /// Delay doubles from `retryBaseDelay` up to `retryMaxDelay` and is randomized within its upper half,
+    /// so clients that lost the backend at the same time do not retry in lockstep.
+    func scheduleRetry() {
+        let delay = min(Self.retryMaxDelay, Self.retryBaseDelay * pow(2, Double(min(retryAttempt, 16))))
+        retryAttempt += 1
+        let work = DispatchWorkItem { [weak self] in
+            self?.retryWork = nil
+            self?.flush()
+        }
+        retryWork = work
+        queue.asyncAfter(deadline: .now() + TimeInterval.random(in: (delay / 2)...delay), execute: work)
+    }
+
+    func cancelRetry() {
+        retryWork?.cancel()
+        retryWork = nil
+    }
+
+    static let retryBaseDelay: TimeInterval = 2
+    static let retryMaxDelay: TimeInterval = 5 * 60
+
+    static func isNetworkError(_ error: Error) -> Bool {
+        if let coreError = error as? GliaCoreError {
+            return coreError.error.map(isNetworkError) ?? false
+        }
+        if let generalError = error as? GeneralError {
+            return generalError == .networkError
+        }
+        return error is URLError
+    }
+
+    func persist() {
+        guard isRestored else { return }
+        guard !pending.isEmpty || !unconfirmed.isEmpty else {
+            try? fileManager.removeItem(at: storageURL)
+            return
+        }
+        let records = unconfirmed.map { Record(payload: $0, wasAttempted: true) }
+            + pending.map { Record(payload: $0, wasAttempted: attemptedIds.contains($0.messageId)) }
+        guard let data = try? JSONEncoder().encode(records) else { return }
+        try? fileManager.createDirectory(
+            at: storageURL.deletingLastPathComponent(),
+            withIntermediateDirectories: true,
+            attributes: [.protectionKey: FileProtectionType.complete]
+        )
+        try? data.write(to: storageURL, options: [.atomic, .completeFileProtection])
+    }
+
+    /// Codable snapshot of `SendMessagePayload`; attachments keep only the values needed to resend them.
+    struct Record: Codable {
+        let content: String
+        let attachmentType: Int?
+        let selectedOption: String?
+        let options: [SingleChoiceOption]?
+        let fileIds: [String]?
+        let imageUrl: String?
+        let wasAttempted: Bool
+
+        init(payload: SendMessagePayload, wasAttempted: Bool) {
+            self.wasAttempted = wasAttempted
+            content = payload.content
+            attachmentType = payload.attachment?.type?.rawValue
+            selectedOption = payload.attachment?.selectedOption
+            options = payload.attachment?.options
+            fileIds = payload.attachment?.files?.compactMap(\.id)
+            imageUrl = payload.attachment?.imageUrl
+        }
+
+        var payload: SendMessagePayload {
+            let hasAttachment = attachmentType != nil || selectedOption != nil || fileIds != nil
+            let attachment = hasAttachment ? Attachment(
+                type: attachmentType.flatMap(AttachmentType.init(rawValue:)),
+                selectedOption: selectedOption,
+                options: options,
+                files: fileIds?.map { EngagementFile(id: $0) },
+                imageUrl: imageUrl
+            ) : nil
+            return SendMessagePayload(content: content, attachment: attachment)
+        }
+    }
+}
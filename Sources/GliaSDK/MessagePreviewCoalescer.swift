@@ -0,0 +1,158 @@
+import Foundation
+import GliaCoreSDK
+import Network
+
+/// Coalesces message previews so that typing produces a bounded number of socket pushes.
+///
+/// Call `update(_:)` on every keystroke. At most one preview is in flight, only the latest text is sent,
+/// and the interval between previews grows with the measured round-trip time and on cellular paths.
+/// A preview that gets no answer within twice `maximumInterval` is considered lost, so later ones are not held back.
+public final class MessagePreviewCoalescer {
+    public typealias Send = (String, @escaping (Bool) -> Void) -> Void
+
+    public struct Configuration {
+        /// Shortest time between two previews.
+        public var minimumInterval: TimeInterval
+        /// Longest time between two previews, regardless of measured latency.
+        public var maximumInterval: TimeInterval
+        /// Interval as a multiple of the smoothed round-trip time.
+        public var roundTripMultiplier: Double
+        /// Extra factor applied while the network path uses a cellular interface.
+        public var cellularMultiplier: Double
+
+        public init(
+            minimumInterval: TimeInterval = 0.3,
+            maximumInterval: TimeInterval = 2,
+            roundTripMultiplier: Double = 2,
+            cellularMultiplier: Double = 1.5
+        ) {
+            self.minimumInterval = minimumInterval
+            self.maximumInterval = maximumInterval
+            self.roundTripMultiplier = roundTripMultiplier
+            self.cellularMultiplier = cellularMultiplier
+        }
+
+        public static let `default` = Configuration()
+    }
+
+    private let configuration: Configuration
+    private let send: Send
+    private let pathMonitor = NWPathMonitor()
+    private let queue = DispatchQueue(label: "com.glia.sdk.message-preview")
+    // Accessed on `queue` only.
+    private var latestText: String?
+    private var lastSentText: String?
+    private var lastSentAt: DispatchTime?
+    private var isInFlight = false
+    private var inFlightId: UUID?
+    private var timeoutWork: DispatchWorkItem?
+    private var scheduledWork: DispatchWorkItem?
+    private var smoothedRoundTrip: TimeInterval?
+    private var isCellular = false
+
+    public init(configuration: Configuration = .default, send: @escaping Send) {
+        self.configuration = configuration
+        self.send = send
+        pathMonitor.pathUpdateHandler = { [weak self] path in
+            self?.isCellular = NetworkPath(rawValue: path).interfaceType == .cellular
+        }
+        pathMonitor.start(queue: queue)
+    }
+
+    deinit {
+        pathMonitor.cancel()
+        scheduledWork?.cancel()
+        timeoutWork?.cancel()
+    }
+
+    /// Coalescer backed by `GliaCore.sendMessagePreview(message:completion:)`.
+    public static func engagement(
+        core: GliaCore = .sharedInstance,
+        configuration: Configuration = .default
+    ) -> MessagePreviewCoalescer {
+        MessagePreviewCoalescer(configuration: configuration) { text, completion in
+            core.sendMessagePreview(message: text) { success, _ in completion(success) }
+        }
+    }
+
+    /// Records the current input text. The preview is sent when the current interval allows it.
+    public func update(_ text: String) {
+        queue.async { [weak self] in
+            guard let self = self else { return }
+            self.latestText = text
+            self.scheduleIfNeeded()
+        }
+    }
+
+    /// Drops a preview that has not been sent yet, for example after the message itself was sent.
+    public func reset() {
+        queue.async { [weak self] in
+            guard let self = self else { return }
+            self.scheduledWork?.cancel()
+            self.scheduledWork = nil
+            self.latestText = nil
+            self.lastSentText = ""
+        }
+    }
+
+    /// Interval currently applied between two previews.
+    public var currentInterval: TimeInterval {
+        queue.sync { interval() }
+    }
+}
+
+private extension MessagePreviewCoalescer {
+    func interval() -> TimeInterval {
+        let base = smoothedRoundTrip.map { $0 * configuration.roundTripMultiplier } ?? configuration.minimumInterval
+        let adjusted = base * (isCellular ? configuration.cellularMultiplier : 1)
+        return min(configuration.maximumInterval, max(configuration.minimumInterval, adjusted))
+    }
+
+    func scheduleIfNeeded() {
+        guard !isInFlight, scheduledWork == nil, let text = latestText, text != lastSentText else { return }
+        let earliest = lastSentAt.map { $0 + interval() } ?? .now()
+        let work = DispatchWorkItem { [weak self] in
+            self?.scheduledWork = nil
+            self?.sendLatest()
+        }
+        scheduledWork = work
+        queue.asyncAfter(deadline: max(earliest, .now()), execute: work)
+    }
+
+    func sendLatest() {
+        guard let text = latestText, text != lastSentText else { return }
+        let id = UUID()
+        isInFlight = true
+        inFlightId = id
+        lastSentText = text
+        let startedAt = DispatchTime.now()
+        lastSentAt = startedAt
+
+        let timeout = 2 * configuration.maximumInterval
+        let work = DispatchWorkItem { [weak self] in
+            // No answer in time; count the timeout as the round trip so the interval backs off.
+            self?.finishInFlight(id, roundTrip: timeout)
+        }
+        timeoutWork = work
+        queue.asyncAfter(deadline: startedAt + timeout, execute: work)
+
+        send(text) { [weak self] _ in
+            self?.queue.async {
+                let roundTrip = Double(DispatchTime.now().uptimeNanoseconds - startedAt.uptimeNanoseconds) / 1_000_000_000
+                self?.finishInFlight(id, roundTrip: roundTrip)
+            }
+        }
+    }
+
+    /// Completes the preview with `id` once; a late answer after a timeout is ignored.
+    func finishInFlight(_ id: UUID, roundTrip: TimeInterval) {
+        guard inFlightId == id else { return }
+        inFlightId = nil
+        timeoutWork?.cancel()
+        timeoutWork = nil
+        // Exponentially weighted moving average, as used for TCP RTT estimation.
+        smoothedRoundTrip = smoothedRoundTrip.map { 0.875 * $0 + 0.125 * roundTrip } ?? roundTrip
+        isInFlight = false
+        scheduleIfNeeded()
+    }
+}
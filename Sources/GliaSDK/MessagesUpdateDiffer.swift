@@ -0,0 +1,173 @@
+import Foundation
+import GliaCoreSDK
+
+/// Structured change between two consecutive snapshots delivered by `MessageHandling.onMessagesUpdated`.
+/// Removed positions refer to the previous snapshot, inserted positions refer to `messages`.
+/// Updated entries carry both, so they can be used as reloads in `performBatchUpdates`
+/// (`previousIndex`) or to read the new content from `messages` (`index`).
+public struct MessagesChange {
+    public struct Entry: Equatable {
+        public let id: String
+        public let index: Int
+    }
+
+    public struct Update: Equatable {
+        public let id: String
+        /// Position in the previous snapshot.
+        public let previousIndex: Int
+        /// Position in `messages`.
+        public let index: Int
+    }
+
+    public let removed: [Entry]
+    public let inserted: [Entry]
+    public let updated: [Update]
+    /// Snapshot the change was computed against.
+    public let messages: [Message]
+
+    public var isEmpty: Bool {
+        removed.isEmpty && inserted.isEmpty && updated.isEmpty
+    }
+}
+
+/// Computes `MessagesChange` values off the main thread from the full message arrays handed out by
+/// `MessageHandling.onMessagesUpdated`, so the integrator can apply batch updates instead of reloading.
+///
+/// Return `onMessagesUpdated` from the `Interactable` implementation and observe either `onChange`
+/// or `changes()`.
+public final class MessagesUpdateDiffer {
+    /// Invoked on `deliveryQueue` for every non-empty change.
+    public var onChange: ((MessagesChange) -> Void)?
+
+    /// Block to hand over to `GliaCore` as `MessageHandling.onMessagesUpdated`.
+    public private(set) lazy var onMessagesUpdated: MessagesUpdateBlock = { [weak self] messages in
+        self?.enqueue(messages)
+    }
+
+    private let deliveryQueue: DispatchQueue
+    private let workQueue = DispatchQueue(label: "com.glia.sdk.messages-differ", qos: .userInitiated)
+    // Accessed on `workQueue` only.
+    private var messages: [Message] = []
+    private var ids: [String] = []
+    private var fingerprints: [String: Fingerprint] = [:]
+    private var continuations: [UUID: AsyncStream<MessagesChange>.Continuation] = [:]
+
+    public init(deliveryQueue: DispatchQueue = .main) {
+        self.deliveryQueue = deliveryQueue
+    }
+
+    deinit {
+        continuations.values.forEach { $0.finish() }
+    }
+
+    /// Stream of non-empty changes. If a snapshot has already been received, the first element describes
+    /// it as insertions; later elements are diffs against the previous snapshot.
+    /// The stream finishes when the differ is deallocated.
+    public func changes() -> AsyncStream<MessagesChange> {
+        AsyncStream { continuation in
+            let token = UUID()
+            workQueue.async { [weak self] in
+                guard let self = self else {
+                    continuation.finish()
+                    return
+                }
+                self.continuations[token] = continuation
+                if !self.messages.isEmpty {
+                    continuation.yield(self.snapshotChange())
+                }
+            }
+            continuation.onTermination = { [weak self] _ in
+                self?.workQueue.async { self?.continuations[token] = nil }
+            }
+        }
+    }
+
+    /// Forgets the previous snapshot, so the next update is reported as a full insertion.
+    public func reset() {
+        workQueue.async { [weak self] in
+            self?.messages = []
+            self?.ids = []
+            self?.fingerprints = [:]
+        }
+    }
+
+    private func enqueue(_ messages: [Message]) {
+        workQueue.async { [weak self] in
+            guard let self = self else { return }
+            let change = self.apply(messages)
+            guard !change.isEmpty else { return }
+            self.continuations.values.forEach { $0.yield(change) }
+            self.deliveryQueue.async { [weak self] in self?.onChange?(change) }
+        }
+    }
+
+    private func apply(_ messages: [Message]) -> MessagesChange {
+        let newIds = messages.map(\.id)
+        var newFingerprints: [String: Fingerprint] = [:]
+        newFingerprints.reserveCapacity(messages.count)
+        messages.forEach { newFingerprints[$0.id] = Fingerprint($0) }
+
+        var removed: [MessagesChange.Entry] = []
+        var inserted: [MessagesChange.Entry] = []
+        for step in newIds.difference(from: ids) {
+            switch step {
+            case let .remove(offset, id, _):
+                removed.append(.init(id: id, index: offset))
+            case let .insert(offset, id, _):
+                inserted.append(.init(id: id, index: offset))
+            }
+        }
+
+        let insertedIds = Set(inserted.map(\.id))
+        var previousIndexes: [String: Int] = [:]
+        previousIndexes.reserveCapacity(ids.count)
+        ids.enumerated().forEach { previousIndexes[$0.element] = $0.offset }
+
+        var updated: [MessagesChange.Update] = []
+        for (index, id) in newIds.enumerated() where !insertedIds.contains(id) {
+            if let old = fingerprints[id], old != newFingerprints[id], let previousIndex = previousIndexes[id] {
+                updated.append(.init(id: id, previousIndex: previousIndex, index: index))
+            }
+        }
+
+        self.messages = messages
+        ids = newIds
+        fingerprints = newFingerprints
+        return MessagesChange(removed: removed, inserted: inserted, updated: updated, messages: messages)
+    }
+
+    private func snapshotChange() -> MessagesChange {
+        MessagesChange(
+            removed: [],
+            inserted: ids.enumerated().map { .init(id: $0.element, index: $0.offset) },
+            updated: [],
+            messages: messages
+        )
+    }
+}
+
+private extension MessagesUpdateDiffer {
+    /// Value-typed snapshot of the parts of `Message` that can change after it is first delivered.
+    struct Fingerprint: Equatable {
+        let content: String
+        let sender: MessageSender
+        let attachmentType: AttachmentType?
+        let selectedOption: String?
+        let optionValues: [String?]
+        let files: [File]
+
+        struct File: Equatable {
+            let id: String?
+            let isDeleted: Bool?
+        }
+
+        init(_ message: Message) {
+            content = message.content
+            sender = message.sender
+            attachmentType = message.attachment?.type
+            selectedOption = message.attachment?.selectedOption
+            optionValues = message.attachment?.options?.map(\.value) ?? []
+            files = message.attachment?.files?.map { File(id: $0.id, isDeleted: $0.isDeleted) } ?? []
+        }
+    }
+}
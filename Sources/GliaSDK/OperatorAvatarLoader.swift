@@ -0,0 +1,233 @@
+import CryptoKit
+import Foundation
+import GliaCoreSDK
+import UIKit
+
+/// Loads operator avatars referenced by `Operator.picture` and `MessageSender.picture`.
+///
+/// Downloaded bytes are kept on disk up to `diskByteLimit`, least recently used first out,
+/// downsampled images are kept in memory per target size, and concurrent requests for the same URL share a single network request.
+/// Decoding and downsampling happen off the main thread; completions are called on the main queue.
+public final class OperatorAvatarLoader {
+    public static let shared = OperatorAvatarLoader()
+
+    public let diskByteLimit: Int
+
+    private let session: URLSession
+    private let diskDirectory: URL
+    private let fileManager: FileManager
+    private let memoryCache = NSCache<NSString, UIImage>()
+    private let queue = DispatchQueue(label: "com.glia.sdk.avatar-loader")
+    private let decodeQueue = DispatchQueue(label: "com.glia.sdk.avatar-loader.decode", qos: .userInitiated, attributes: .concurrent)
+    // Accessed on `queue` only.
+    private var waiters: [URL: [UUID: (Data?) -> Void]] = [:]
+    private var tasks: [URL: (id: UUID, task: URLSessionDataTask)] = [:]
+
+    /// - Parameters:
+    ///   - memoryCostLimit: Upper bound in bytes for decoded images kept in memory, 20 MB by default.
+    ///   - diskByteLimit: Upper bound in bytes for downloaded images kept on disk, 20 MB by default.
+    public init(
+        session: URLSession = .shared,
+        diskDirectory: URL? = nil,
+        memoryCostLimit: Int = 20 * 1024 * 1024,
+        diskByteLimit: Int = 20 * 1024 * 1024,
+        fileManager: FileManager = .default
+    ) {
+        let caches = fileManager.urls(for: .cachesDirectory, in: .userDomainMask)[0]
+        let diskDirectory = diskDirectory ?? caches.appendingPathComponent("GliaOperatorAvatars", isDirectory: true)
+        try? fileManager.createDirectory(at: diskDirectory, withIntermediateDirectories: true)
+        self.session = session
+        self.diskDirectory = diskDirectory
+        self.fileManager = fileManager
+        self.diskByteLimit = diskByteLimit
+        memoryCache.totalCostLimit = memoryCostLimit
+    }
+
+    /// Loads the image at `urlString` downsampled to fit `pointSize` at `scale`.
+    /// Completion receives `nil` when the URL is missing or invalid, or loading fails.
+    /// Once the returned value is cancelled, `completion` is never called.
+    @discardableResult
+    public func loadImage(
+        from urlString: String?,
+        pointSize: CGSize,
+        scale: CGFloat,
+        completion: @escaping (UIImage?) -> Void
+    ) -> GliaCore.Cancellable {
+        guard let url = urlString.flatMap(URL.init(string:)) else {
+            DispatchQueue.main.async { completion(nil) }
+            return GliaCore.Cancellable(isCancelled: true)
+        }
+        let maxPixelSize = max(pointSize.width, pointSize.height) * scale
+        let key = "\(url.absoluteString)|\(Int(maxPixelSize.rounded(.up)))" as NSString
+        if let image = memoryCache.object(forKey: key) {
+            DispatchQueue.main.async { completion(image) }
+            return GliaCore.Cancellable(isCancelled: true)
+        }
+
+        let token = UUID()
+        queue.async { [weak self] in
+            self?.addWaiter(token, for: url) { data in
+                self?.decodeQueue.async {
+                    let image = data
+                        .flatMap(ImageDownsampling.source(data:))
+                        .flatMap { ImageDownsampling.thumbnail(from: $0, maxPixelSize: maxPixelSize) }
+                        .map { UIImage(cgImage: $0, scale: scale, orientation: .up) }
+                    if let image = image, let cgImage = image.cgImage {
+                        self?.memoryCache.setObject(image, forKey: key, cost: cgImage.bytesPerRow * cgImage.height)
+                    }
+                    DispatchQueue.main.async { completion(image) }
+                }
+            }
+        }
+        return GliaCore.Cancellable { [weak self] in
+            self?.queue.async { self?.removeWaiter(token, for: url) }
+        }
+    }
+
+    /// Async variant of `loadImage(from:pointSize:scale:completion:)`.
+    /// Cancelling the calling task cancels the request and returns `nil`.
+    public func image(from urlString: String?, pointSize: CGSize, scale: CGFloat) async -> UIImage? {
+        let request = PendingAvatarRequest()
+        return await withTaskCancellationHandler {
+            await withCheckedContinuation { continuation in
+                request.start(continuation) {
+                    self.loadImage(from: urlString, pointSize: pointSize, scale: scale) { image in
+                        request.finish(image)
+                    }
+                }
+            }
+        } onCancel: {
+            request.cancel()
+        }
+    }
+
+    /// Drops decoded images from memory. Disk contents are kept.
+    public func clearMemoryCache() {
+        memoryCache.removeAllObjects()
+    }
+
+    /// Removes downloaded images from disk. Requests in flight still complete.
+    public func clearDiskCache() {
+        queue.async { [weak self] in
+            guard let self = self else { return }
+            try? self.fileManager.removeItem(at: self.diskDirectory)
+            try? self.fileManager.createDirectory(at: self.diskDirectory, withIntermediateDirectories: true)
+        }
+    }
+}
+
+private extension OperatorAvatarLoader {
+    func diskURL(for url: URL) -> URL {
+        let name = SHA256.hash(data: Data(url.absoluteString.utf8)).map { String(format: "%02x", $0) }.joined()
+        return diskDirectory.appendingPathComponent(name)
+    }
+
+    func addWaiter(_ token: UUID, for url: URL, completion: @escaping (Data?) -> Void) {
+        if waiters[url] != nil {
+            waiters[url]?[token] = completion
+            return
+        }
+        let fileURL = diskURL(for: url)
+        if let data = try? Data(contentsOf: fileURL, options: .mappedIfSafe) {
+            // Modification date doubles as the last access time for eviction.
+            try? fileManager.setAttributes([.modificationDate: Date()], ofItemAtPath: fileURL.path)
+            completion(data)
+            return
+        }
+        waiters[url] = [token: completion]
+        let taskId = UUID()
+        let task = session.dataTask(with: url) { [weak self] data, response, _ in
+            let isSuccess = (response as? HTTPURLResponse).map { (200..<300).contains($0.statusCode) } ?? true
+            let data = isSuccess ? data : nil
+            self?.queue.async {
+                guard let self = self else { return }
+                if let data = data, (try? data.write(to: fileURL, options: .atomic)) != nil {
+                    self.trimDiskCache()
+                }
+                // A cancelled request may finish after a new one for the same URL was started.
+                guard self.tasks[url]?.id == taskId else { return }
+                self.tasks[url] = nil
+                self.waiters.removeValue(forKey: url)?.values.forEach { $0(data) }
+            }
+        }
+        tasks[url] = (taskId, task)
+        task.resume()
+    }
+
+    func trimDiskCache() {
+        let keys: Set<URLResourceKey> = [.fileSizeKey, .contentModificationDateKey]
+        guard let files = try? fileManager.contentsOfDirectory(
+            at: diskDirectory,
+            includingPropertiesForKeys: Array(keys)
+        ) else { return }
+        var entries = files.compactMap { file -> (url: URL, size: Int, date: Date)? in
+            guard let values = try? file.resourceValues(forKeys: keys) else { return nil }
+            return (file, values.fileSize ?? 0, values.contentModificationDate ?? .distantPast)
+        }
+        var size = entries.reduce(0) { $0 + $1.size }
+        guard size > diskByteLimit else { return }
+        entries.sort { $0.date < $1.date }
+        for entry in entries where size > diskByteLimit {
+            try? fileManager.removeItem(at: entry.url)
+            size -= entry.size
+        }
+    }
+
+    func removeWaiter(_ token: UUID, for url: URL) {
+        waiters[url]?[token] = nil
+        guard waiters[url]?.isEmpty == true else { return }
+        waiters[url] = nil
+        tasks.removeValue(forKey: url)?.task.cancel()
+    }
+}
+
+/// Resumes the continuation of `OperatorAvatarLoader.image(from:pointSize:scale:)` exactly once,
+/// whether the image arrives or the task is cancelled first.
+private final class PendingAvatarRequest {
+    private let lock = NSLock()
+    private var continuation: CheckedContinuation<UIImage?, Never>?
+    private var cancellable: GliaCore.Cancellable?
+    private var isCancelled = false
+
+    func start(_ continuation: CheckedContinuation<UIImage?, Never>, load: () -> GliaCore.Cancellable) {
+        lock.lock()
+        guard !isCancelled else {
+            lock.unlock()
+            continuation.resume(returning: nil)
+            return
+        }
+        self.continuation = continuation
+        lock.unlock()
+
+        let cancellable = load()
+        lock.lock()
+        let isCancelled = self.isCancelled
+        if !isCancelled {
+            self.cancellable = cancellable
+        }
+        lock.unlock()
+        if isCancelled {
+            cancellable.cancel()
+        }
+    }
+
+    func finish(_ image: UIImage?) {
+        lock.lock()
+        let continuation = self.continuation
+        self.continuation = nil
+        lock.unlock()
+        continuation?.resume(returning: image)
+    }
+
+    func cancel() {
+        lock.lock()
+        isCancelled = true
+        let continuation = self.continuation
+        let cancellable = self.cancellable
+        self.continuation = nil
+        self.cancellable = nil
+        lock.unlock()
+        cancellable?.cancel()
+        continuation?.resume(returning: nil)
+    }
+}
@@ -0,0 +1,117 @@
+import Foundation
+import GliaCoreSDK
+
+/// In-memory cache for `GliaCore.listQueues(completion:)` with stale-while-revalidate semantics.
+///
+/// Cached queues are returned immediately. When the cached list is older than `timeToLive`, it is still
+/// returned and a single background request refreshes it. Between refreshes, statuses of cached queues
+/// are kept current through a `QueuesSnapshotSubscription`.
+public final class QueuesCache {
+    public static let shared = QueuesCache()
+
+    public let timeToLive: TimeInterval
+
+    /// Called on the main queue whenever the cached list changes after a revalidation or a queue update.
+    public var onUpdate: (([Queue]) -> Void)?
+
+    private let core: GliaCore
+    private let observationPolicy: SocketObservationPolicy?
+    private let queue: DispatchQueue
+    // Accessed on `queue` only.
+    private let cache: StaleWhileRevalidate<[Queue], GliaCoreError>
+    private var subscription: QueuesSnapshotSubscription?
+
+    /// - Parameters:
+    ///   - observationPolicy: Forwarded to the `QueuesSnapshotSubscription` that keeps cached statuses current.
+    public init(
+        timeToLive: TimeInterval = 60,
+        core: GliaCore = .sharedInstance,
+        observationPolicy: SocketObservationPolicy? = nil
+    ) {
+        self.timeToLive = timeToLive
+        self.core = core
+        self.observationPolicy = observationPolicy
+        let queue = DispatchQueue(label: "com.glia.sdk.queues-cache")
+        self.queue = queue
+        self.cache = StaleWhileRevalidate(timeToLive: timeToLive, queue: queue) { completion in
+            core.listQueues { queues, error in
+                if let queues = queues {
+                    completion(.success(queues))
+                } else {
+                    completion(.failure(error ?? GliaCoreError(reason: "Queues are missing", error: GeneralError.internalError)))
+                }
+            }
+        }
+        cache.onRevalidate = { [weak self] fetched, previous in
+            self?.revalidated(fetched, previous: previous)
+        }
+    }
+
+    /// Same contract as `GliaCore.listQueues(completion:)`; completion is called on the main queue.
+    public func listQueues(completion: @escaping QueueRequestBlock) {
+        queue.async { [weak self] in
+            self?.cache.get { result in
+                switch result {
+                case let .success(queues):
+                    completion(queues, nil)
+                case let .failure(error):
+                    completion(nil, error)
+                }
+            }
+        }
+    }
+
+    /// Cached queues without triggering a request, or `nil` when nothing is cached yet.
+    public var cachedQueues: [Queue]? {
+        queue.sync { cache.value }
+    }
+
+    /// Drops cached queues and stops observing queue updates. A request still in flight
+    /// does not repopulate the cache.
+    public func invalidate() {
+        queue.async { [weak self] in
+            self?.cache.invalidate()
+            self?.subscription?.cancel()
+            self?.subscription = nil
+        }
+    }
+}
+
+private extension QueuesCache {
+    func revalidated(_ fetched: [Queue], previous: [Queue]?) {
+        if Self.differ(previous, fetched) {
+            DispatchQueue.main.async { [weak self] in self?.onUpdate?(fetched) }
+        }
+        let ids = fetched.map(\.id)
+        if previous.map({ Set($0.map(\.id)) }) != Set(ids) || subscription == nil {
+            subscription?.cancel()
+            subscription = QueuesSnapshotSubscription(
+                queueIds: ids,
+                initialQueues: fetched,
+                core: core,
+                observationPolicy: observationPolicy
+            ) { [weak self] snapshot in
+                self?.queue.async { self?.apply(snapshot) }
+            }
+        }
+    }
+
+    func apply(_ snapshot: QueuesSnapshot) {
+        guard let current = cache.value else { return }
+        let updated = current.map { snapshot.queues[$0.id] ?? $0 }
+        guard Self.differ(current, updated) else { return }
+        cache.update(updated)
+        DispatchQueue.main.async { [weak self] in self?.onUpdate?(updated) }
+    }
+
+    /// Compares the fields a queue list is rendered from; refreshed `Queue` instances are always new objects.
+    static func differ(_ lhs: [Queue]?, _ rhs: [Queue]) -> Bool {
+        guard let lhs = lhs, lhs.count == rhs.count else { return true }
+        return zip(lhs, rhs).contains { old, new in
+            old.id != new.id
+                || old.state.status != new.state.status
+                || old.state.media != new.state.media
+                || old.lastUpdated != new.lastUpdated
+        }
+    }
+}
@@ -0,0 +1,159 @@
+import Foundation
+import GliaCoreSDK
+
+/// State of all subscribed queues together with what changed since the previous snapshot.
+public struct QueuesSnapshot {
+    /// Changed fields of a single queue. Fields that did not change are `nil`.
+    public struct Change {
+        public let queueId: String
+        public let status: QueueStatus?
+        public let media: [MediaType]?
+        public let lastUpdated: Date
+    }
+
+    /// Latest known queues keyed by queue id.
+    public let queues: [String: Queue]
+    /// Changes since the previous snapshot. For the first snapshot every queue is reported as changed.
+    public let changes: [Change]
+}
+
+/// Subscribes to updates of several queues and delivers them as coalesced snapshots.
+///
+/// The first snapshot contains all requested queues known to `listQueues(completion:)`.
+/// Individual updates from `subscribeForQueuesUpdates(forQueues:completion:)` are collected and
+/// delivered at most once per `minimumInterval`, on the main queue.
+/// When an `observationPolicy` is given, the subscription holds a `.queueUpdates` need on it until it is
+/// cancelled or deallocated, so the socket carrying the updates stays observed.
+public final class QueuesSnapshotSubscription {
+    public let queueIds: [String]
+    public let minimumInterval: TimeInterval
+
+    private let core: GliaCore
+    private let onSnapshot: (QueuesSnapshot) -> Void
+    private let onError: ((GliaCoreError) -> Void)?
+    private let socketNeed: GliaCore.Cancellable?
+    private let queue = DispatchQueue(label: "com.glia.sdk.queues-snapshot")
+    // Accessed on `queue` only.
+    private var queues: [String: Queue] = [:]
+    private var changedIds: [String] = []
+    private var lastDeliveredQueues: [String: Queue] = [:]
+    private var lastDeliveryAt: DispatchTime?
+    private var isDeliveryScheduled = false
+    private var isCancelled = false
+    // Set once during initialization.
+    private var callbackId: String?
+
+    /// - Parameters:
+    ///   - initialQueues: Queues already known to the caller. When given, the initial `listQueues` request is skipped.
+    ///   - observationPolicy: Policy managing socket observation, if the integrator uses one. Without it the
+    ///     subscription never starts or stops socket observation.
+    public init(
+        queueIds: [String],
+        minimumInterval: TimeInterval = 0.5,
+        initialQueues: [Queue]? = nil,
+        core: GliaCore = .sharedInstance,
+        observationPolicy: SocketObservationPolicy? = nil,
+        onError: ((GliaCoreError) -> Void)? = nil,
+        onSnapshot: @escaping (QueuesSnapshot) -> Void
+    ) {
+        self.queueIds = queueIds
+        self.minimumInterval = minimumInterval
+        self.core = core
+        self.onError = onError
+        self.onSnapshot = onSnapshot
+        self.socketNeed = observationPolicy?.acquire(.queueUpdates)
+
+        if let initialQueues = initialQueues {
+            queue.async { [weak self] in self?.receive(initialQueues) }
+        } else {
+            core.listQueues { [weak self] queues, error in
+                if let error = error {
+                    self?.deliver(error)
+                }
+                self?.queue.async { self?.receive(queues ?? []) }
+            }
+        }
+        callbackId = core.subscribeForQueuesUpdates(forQueues: queueIds) { [weak self] result in
+            switch result {
+            case let .success(update):
+                self?.queue.async { self?.receive([update]) }
+            case let .failure(error):
+                self?.deliver(error)
+            }
+        }
+    }
+
+    deinit {
+        // Deinit may run on `queue` when a pending block held the last reference, so no `queue.sync` here.
+        if !isCancelled, let callbackId = callbackId {
+            core.unsubscribeFromUpdates(queueCallbackId: callbackId) { _ in }
+        }
+        socketNeed?.cancel()
+    }
+
+    /// Stops receiving updates. Pending changes are discarded.
+    public func cancel() {
+        queue.sync {
+            guard !isCancelled else { return }
+            isCancelled = true
+            if let callbackId = callbackId {
+                core.unsubscribeFromUpdates(queueCallbackId: callbackId) { _ in }
+            }
+        }
+        socketNeed?.cancel()
+    }
+}
+
+private extension QueuesSnapshotSubscription {
+    func receive(_ updates: [Queue]) {
+        guard !isCancelled else { return }
+        let requested = Set(queueIds)
+        for update in updates where requested.contains(update.id) {
+            if let current = queues[update.id], current.lastUpdated > update.lastUpdated {
+                continue
+            }
+            queues[update.id] = update
+            if !changedIds.contains(update.id) {
+                changedIds.append(update.id)
+            }
+        }
+        scheduleDelivery()
+    }
+
+    func scheduleDelivery() {
+        guard !isDeliveryScheduled, !changedIds.isEmpty else { return }
+        isDeliveryScheduled = true
+        let earliest = lastDeliveryAt.map { $0 + minimumInterval } ?? .now()
+        queue.asyncAfter(deadline: max(earliest, .now())) { [weak self] in
+            self?.flush()
+        }
+    }
+
+    func flush() {
+        isDeliveryScheduled = false
+        guard !isCancelled, !changedIds.isEmpty else { return }
+        let changes: [QueuesSnapshot.Change] = changedIds.compactMap { id in
+            guard let current = queues[id] else { return nil }
+            let previous = lastDeliveredQueues[id]
+            let status = previous?.state.status == current.state.status ? nil : current.state.status
+            let media = previous?.state.media == current.state.media ? nil : current.state.media
+            guard previous == nil || status != nil || media != nil || previous?.lastUpdated != current.lastUpdated else {
+                return nil
+            }
+            return .init(queueId: id, status: status, media: media, lastUpdated: current.lastUpdated)
+        }
+        changedIds = []
+        lastDeliveredQueues = queues
+        lastDeliveryAt = .now()
+        guard !changes.isEmpty else { return }
+        let snapshot = QueuesSnapshot(queues: queues, changes: changes)
+        DispatchQueue.main.async { [weak self] in
+            guard self?.queue.sync(execute: { self?.isCancelled }) == false else { return }
+            self?.onSnapshot(snapshot)
+        }
+    }
+
+    func deliver(_ error: GliaCoreError) {
+        DispatchQueue.main.async { [weak self] in self?.onError?(error) }
+    }
+}
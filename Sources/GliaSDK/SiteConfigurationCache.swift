@@ -0,0 +1,70 @@
+import Foundation
+import GliaCoreSDK
+
+/// In-memory cache for `GliaCore.fetchSiteConfiguration(_:)`.
+///
+/// A cached `Site` is returned immediately; once it is older than `timeToLive` it is still returned and
+/// revalidated in the background. Concurrent requests share one network call, and `changes()` emits only
+/// when the revalidated `Site` differs from the cached one.
+public final class SiteConfigurationCache {
+    public static let shared = SiteConfigurationCache()
+
+    public let timeToLive: TimeInterval
+
+    private let core: GliaCore
+    /// Last `Site` handed to `changes()` subscribers.
+    private let relay = ValueRelay<Site?>(nil)
+    private let queue: DispatchQueue
+    // Accessed on `queue` only.
+    private let cache: StaleWhileRevalidate<Site, Error>
+
+    public init(timeToLive: TimeInterval = 300, core: GliaCore = .sharedInstance) {
+        self.timeToLive = timeToLive
+        self.core = core
+        let queue = DispatchQueue(label: "com.glia.sdk.site-configuration-cache")
+        self.queue = queue
+        self.cache = StaleWhileRevalidate(timeToLive: timeToLive, queue: queue) { completion in
+            core.fetchSiteConfiguration(completion)
+        }
+        cache.onRevalidate = { [relay] site, _ in
+            if relay.current() != site {
+                relay.set(site)
+            }
+        }
+    }
+
+    /// Same contract as `GliaCore.fetchSiteConfiguration(_:)`; completion is called on the main queue.
+    public func fetchSiteConfiguration(_ completion: @escaping (Result<Site, Error>) -> Void) {
+        queue.async { [weak self] in
+            self?.cache.get(completion)
+        }
+    }
+
+    /// Emits the last known `Site`, if any, followed by every revalidated `Site` that differs from the previous one.
+    public func changes() -> AsyncStream<Site> {
+        let sites = relay.stream()
+        return AsyncStream { continuation in
+            let task = Task {
+                for await site in sites {
+                    guard let site = site else { continue }
+                    continuation.yield(site)
+                }
+                continuation.finish()
+            }
+            continuation.onTermination = { _ in task.cancel() }
+        }
+    }
+
+    public var cachedSite: Site? {
+        queue.sync { cache.value }
+    }
+
+    /// Forces the next request to hit the network, for example after `GliaCore.configure` with another site.
+    /// A request still in flight does not repopulate the cache. `changes()` emits again only if the refetched
+    /// `Site` differs from the last emitted one.
+    public func invalidate() {
+        queue.async { [weak self] in
+            self?.cache.invalidate()
+        }
+    }
+}
@@ -0,0 +1,148 @@
+import Foundation
+import GliaCoreSDK
+import UIKit
+
+/// Decides when `GliaCore.startSocketObservation()` and `stopSocketObservation()` are called.
+///
+/// Features that need realtime updates acquire a `Need` and cancel the returned handle when done.
+/// The socket is observed while at least one need is held and the app is in the foreground.
+/// After entering the background it is suspended once `backgroundGracePeriod` passes, unless an
+/// engagement is active, and resumed as soon as the app returns to the foreground.
+public final class SocketObservationPolicy {
+    public enum Need: Hashable {
+        case engagement
+        case queueUpdates
+        case unreadMessageCount
+        case pendingSecureConversationStatus
+        case custom(String)
+
+        /// Needs that keep the socket open while the app is in the background.
+        var keepsAliveInBackground: Bool {
+            self == .engagement
+        }
+    }
+
+    public enum State: Equatable {
+        /// No feature needs the socket.
+        case idle
+        case observing
+        /// Needs are held, but the socket was stopped while the app is in the background.
+        case suspended
+    }
+
+    public static let shared = SocketObservationPolicy()
+
+    public let backgroundGracePeriod: TimeInterval
+
+    private let core: GliaCore
+    private let notificationCenter: NotificationCenter
+    private let relay = ValueRelay<State>(.idle)
+    // Accessed on the main queue only.
+    private var needs: [UUID: Need] = [:]
+    private var isInBackground = false
+    private var suspendWork: DispatchWorkItem?
+    private var observers: [NSObjectProtocol] = []
+
+    public init(
+        core: GliaCore = .sharedInstance,
+        backgroundGracePeriod: TimeInterval = 10,
+        notificationCenter: NotificationCenter = .default
+    ) {
+        self.core = core
+        self.backgroundGracePeriod = backgroundGracePeriod
+        self.notificationCenter = notificationCenter
+        observers = [
+            notificationCenter.addObserver(
+                forName: UIApplication.didEnterBackgroundNotification,
+                object: nil,
+                queue: .main
+            ) { [weak self] _ in
+                self?.isInBackground = true
+                self?.evaluate()
+            },
+            notificationCenter.addObserver(
+                forName: UIApplication.willEnterForegroundNotification,
+                object: nil,
+                queue: .main
+            ) { [weak self] _ in
+                self?.isInBackground = false
+                self?.evaluate()
+            }
+        ]
+        // A policy created during a background launch (push, background fetch) must not open the socket.
+        onMain { [weak self] in
+            self?.isInBackground = UIApplication.shared.applicationState == .background
+            self?.evaluate()
+        }
+    }
+
+    deinit {
+        observers.forEach { notificationCenter.removeObserver($0) }
+        suspendWork?.cancel()
+    }
+
+    /// Registers a need for the socket. Cancel the returned handle once the feature no longer needs it.
+    public func acquire(_ need: Need) -> GliaCore.Cancellable {
+        let token = UUID()
+        onMain { [weak self] in
+            self?.needs[token] = need
+            self?.evaluate()
+        }
+        return GliaCore.Cancellable { [weak self] in
+            self?.onMain {
+                self?.needs[token] = nil
+                self?.evaluate()
+            }
+        }
+    }
+
+    public var state: State {
+        relay.current()
+    }
+
+    /// Emits the current state followed by every state change.
+    public func states() -> AsyncStream<State> {
+        relay.stream()
+    }
+}
+
+private extension SocketObservationPolicy {
+    func onMain(_ work: @escaping () -> Void) {
+        if Thread.isMainThread {
+            work()
+        } else {
+            DispatchQueue.main.async(execute: work)
+        }
+    }
+
+    func evaluate() {
+        suspendWork?.cancel()
+        suspendWork = nil
+
+        if needs.isEmpty {
+            transition(to: .idle)
+        } else if !isInBackground || needs.values.contains(where: \.keepsAliveInBackground) {
+            transition(to: .observing)
+        } else if state == .observing {
+            let work = DispatchWorkItem { [weak self] in self?.transition(to: .suspended) }
+            suspendWork = work
+            DispatchQueue.main.asyncAfter(deadline: .now() + backgroundGracePeriod, execute: work)
+        } else {
+            transition(to: .suspended)
+        }
+    }
+
+    func transition(to newState: State) {
+        let oldState = state
+        guard oldState != newState else { return }
+        switch (oldState == .observing, newState == .observing) {
+        case (false, true):
+            core.startSocketObservation()
+        case (true, false):
+            core.stopSocketObservation()
+        default:
+            break
+        }
+        relay.set(newState)
+    }
+}
@@ -0,0 +1,83 @@
+import Foundation
+
+/// Stale-while-revalidate state shared by the in-memory caches.
+///
+/// Not thread safe: the owner calls it on its own serial `queue`, which is also where fetch results are applied.
+/// Every `invalidate()` starts a new generation; results of requests started in an earlier generation are dropped,
+/// and callers waiting at that point are answered by a request of the current generation.
+final class StaleWhileRevalidate<Value, Failure: Error> {
+    typealias Fetch = (@escaping (Result<Value, Failure>) -> Void) -> Void
+
+    let timeToLive: TimeInterval
+    /// Called on `queue` after a successful fetch with the new and the previously cached value.
+    var onRevalidate: ((Value, Value?) -> Void)?
+
+    private(set) var value: Value?
+    private let queue: DispatchQueue
+    private let fetchValue: Fetch
+    private var fetchedAt: Date?
+    private var generation = 0
+    private var inFlightGeneration: Int?
+    private var waiters: [(Result<Value, Failure>) -> Void] = []
+
+    init(timeToLive: TimeInterval, queue: DispatchQueue, fetch: @escaping Fetch) {
+        self.timeToLive = timeToLive
+        self.queue = queue
+        self.fetchValue = fetch
+    }
+
+    /// Answers from the cached value and revalidates it in the background once it is older than `timeToLive`.
+    /// Without a cached value, waits for a request of the current generation. Completion is called on the main queue.
+    func get(_ completion: @escaping (Result<Value, Failure>) -> Void) {
+        guard let value = value, let fetchedAt = fetchedAt else {
+            waiters.append(completion)
+            revalidate()
+            return
+        }
+        DispatchQueue.main.async { completion(.success(value)) }
+        if Date().timeIntervalSince(fetchedAt) > timeToLive {
+            revalidate()
+        }
+    }
+
+    /// Replaces the cached value without resetting its age, for updates pushed between revalidations.
+    func update(_ newValue: Value) {
+        guard value != nil else { return }
+        value = newValue
+    }
+
+    /// Drops the cached value and any result still in flight.
+    func invalidate() {
+        generation += 1
+        inFlightGeneration = nil
+        value = nil
+        fetchedAt = nil
+        if !waiters.isEmpty {
+            revalidate()
+        }
+    }
+
+    private func revalidate() {
+        guard inFlightGeneration != generation else { return }
+        let requestGeneration = generation
+        inFlightGeneration = requestGeneration
+        fetchValue { [weak self] result in
+            self?.queue.async { self?.complete(result, generation: requestGeneration) }
+        }
+    }
+
+    private func complete(_ result: Result<Value, Failure>, generation requestGeneration: Int) {
+        guard requestGeneration == generation else { return }
+        inFlightGeneration = nil
+        let waiters = self.waiters
+        self.waiters = []
+        if case let .success(fetched) = result {
+            let previous = value
+            value = fetched
+            fetchedAt = Date()
+            onRevalidate?(fetched, previous)
+        }
+        // Keep serving the stale value on failure; only callers without a cached value see the error.
+        DispatchQueue.main.async { waiters.forEach { $0(result) } }
+    }
+}
@@ -0,0 +1,95 @@
+import GliaCoreSDK
+@testable import GliaSDK
+import XCTest
+
+final class MessagesUpdateDifferTests: XCTestCase {
+    private var differ: MessagesUpdateDiffer!
+
+    override func setUp() {
+        super.setUp()
+        differ = MessagesUpdateDiffer(deliveryQueue: .main)
+    }
+
+    override func tearDown() {
+        differ = nil
+        super.tearDown()
+    }
+
+    func testInsertRemoveAndMove() throws {
+        apply(["a", "b", "c", "d"])
+
+        let change = try XCTUnwrap(apply(["d", "a", "c", "e"]))
+
+        XCTAssertEqual(change.removed.map(\.id).sorted(), ["b", "d"])
+        XCTAssertEqual(change.inserted.map(\.id).sorted(), ["d", "e"])
+        XCTAssertEqual(change.inserted.first { $0.id == "d" }?.index, 0)
+        XCTAssertEqual(change.inserted.first { $0.id == "e" }?.index, 3)
+        XCTAssertEqual(change.removed.first { $0.id == "b" }?.index, 1)
+        XCTAssertEqual(change.removed.first { $0.id == "d" }?.index, 3)
+        XCTAssertTrue(change.updated.isEmpty)
+    }
+
+    func testContentUpdateReportsPreviousAndNewIndex() throws {
+        apply(["a", "b", "c"])
+
+        let change = try XCTUnwrap(apply(["x", "a", "b", "c"], contents: ["b": "edited"]))
+
+        XCTAssertEqual(change.inserted, [.init(id: "x", index: 0)])
+        XCTAssertTrue(change.removed.isEmpty)
+        XCTAssertEqual(change.updated.count, 1)
+        XCTAssertEqual(change.updated.first?.id, "b")
+        XCTAssertEqual(change.updated.first?.previousIndex, 1)
+        XCTAssertEqual(change.updated.first?.index, 2)
+    }
+
+    func testUnchangedSnapshotProducesNoChange() {
+        apply(["a", "b"])
+
+        XCTAssertNil(apply(["a", "b"]))
+    }
+
+    func testLateSubscriberReceivesCurrentSnapshot() {
+        apply(["a", "b"])
+        apply(["a", "b", "c"])
+
+        let received = expectation(description: "received")
+        let stream = differ.changes()
+        Task {
+            var iterator = stream.makeAsyncIterator()
+            let first = await iterator.next()
+            XCTAssertEqual(first?.inserted.map(\.id), ["a", "b", "c"])
+            XCTAssertEqual(first?.inserted.map(\.index), [0, 1, 2])
+            XCTAssertEqual(first?.removed.isEmpty, true)
+            XCTAssertEqual(first?.updated.isEmpty, true)
+            XCTAssertEqual(first?.messages.map(\.id), ["a", "b", "c"])
+            received.fulfill()
+        }
+        wait(for: [received], timeout: 1)
+    }
+}
+
+private extension MessagesUpdateDifferTests {
+    /// Feeds a snapshot to the differ and returns the change it reports, or `nil` when it reports none.
+    @discardableResult
+    func apply(_ ids: [String], contents: [String: String] = [:]) -> MessagesChange? {
+        var change: MessagesChange?
+        differ.onChange = { change = $0 }
+        differ.onMessagesUpdated(ids.map { message(id: $0, content: contents[$0] ?? $0) })
+        // Empty changes are not delivered, so give the differ time to report one before reading the result.
+        let settled = expectation(description: "settled")
+        DispatchQueue.main.asyncAfter(deadline: .now() + 0.2) { settled.fulfill() }
+        wait(for: [settled], timeout: 1)
+        differ.onChange = nil
+        return change
+    }
+
+    func message(id: String, content: String) -> Message {
+        Message(id: id, content: content, sender: Self.visitor, metadata: nil)
+    }
+
+    /// `MessageSender` has no public memberwise initializer.
+    static let visitor: MessageSender = {
+        let json = Data(#"{"type":"visitor"}"#.utf8)
+        return try! JSONDecoder().decode(MessageSender.self, from: json)
+    }()
+}
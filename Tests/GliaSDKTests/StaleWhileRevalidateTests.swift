@@ -0,0 +1,109 @@
+@testable import GliaSDK
+import XCTest
+
+private struct TestError: Error, Equatable {}
+
+final class StaleWhileRevalidateTests: XCTestCase {
+    private var queue: DispatchQueue!
+    private var requests: [(Result<String, TestError>) -> Void] = []
+    private var cache: StaleWhileRevalidate<String, TestError>!
+
+    override func setUp() {
+        super.setUp()
+        queue = DispatchQueue(label: "com.glia.sdk.tests.stale-while-revalidate")
+        requests = []
+        makeCache(timeToLive: 60)
+    }
+
+    func testConcurrentColdGetsShareOneRequest() {
+        let first = expectation(description: "first")
+        let second = expectation(description: "second")
+        queue.sync {
+            cache.get { result in
+                XCTAssertEqual(try? result.get(), "value")
+                first.fulfill()
+            }
+            cache.get { result in
+                XCTAssertEqual(try? result.get(), "value")
+                second.fulfill()
+            }
+        }
+        XCTAssertEqual(requests.count, 1)
+
+        resolve(0, with: .success("value"))
+        wait(for: [first, second], timeout: 1)
+        XCTAssertEqual(queue.sync { cache.value }, "value")
+    }
+
+    func testServesStaleValueWhileRevalidatingAfterTimeToLive() {
+        makeCache(timeToLive: 0)
+        get()
+        resolve(0, with: .success("old"))
+
+        let stale = expectation(description: "stale")
+        queue.sync {
+            cache.get { result in
+                XCTAssertEqual(try? result.get(), "old")
+                stale.fulfill()
+            }
+        }
+        wait(for: [stale], timeout: 1)
+        XCTAssertEqual(requests.count, 2)
+
+        resolve(1, with: .success("new"))
+        XCTAssertEqual(queue.sync { cache.value }, "new")
+    }
+
+    func testDropsResultRequestedBeforeInvalidate() {
+        let answered = expectation(description: "answered")
+        queue.sync {
+            cache.get { result in
+                XCTAssertEqual(try? result.get(), "current")
+                answered.fulfill()
+            }
+            cache.invalidate()
+        }
+        // The waiter is moved to a request of the new generation.
+        XCTAssertEqual(requests.count, 2)
+
+        resolve(0, with: .success("outdated"))
+        XCTAssertNil(queue.sync { cache.value })
+
+        resolve(1, with: .success("current"))
+        wait(for: [answered], timeout: 1)
+        XCTAssertEqual(queue.sync { cache.value }, "current")
+    }
+
+    func testKeepsCachedValueWhenRevalidationFails() {
+        makeCache(timeToLive: 0)
+        get()
+        resolve(0, with: .success("cached"))
+
+        get()
+        XCTAssertEqual(requests.count, 2)
+        resolve(1, with: .failure(TestError()))
+        XCTAssertEqual(queue.sync { cache.value }, "cached")
+
+        get()
+        XCTAssertEqual(requests.count, 3)
+    }
+}
+
+private extension StaleWhileRevalidateTests {
+    func makeCache(timeToLive: TimeInterval) {
+        cache = StaleWhileRevalidate(timeToLive: timeToLive, queue: queue) { [unowned self] completion in
+            self.requests.append(completion)
+        }
+    }
+
+    /// Calls `get` without observing its result.
+    func get() {
+        queue.sync { cache.get { _ in } }
+    }
+
+    /// Completes request `index` and waits until the result has been applied on `queue`.
+    func resolve(_ index: Int, with result: Result<String, TestError>) {
+        requests[index](result)
+        queue.sync {}
+    }
+}